@@ -0,0 +1,203 @@
+#include "app_state.h"
+#include <string.h>
+
+// Key handling runs from the main task only; the tick path lives in
+// app_state.c so linker.lf can place the two objects separately.
+
+static const int kPresets[] = { 30, 60, 90, 120, 180, 300 };
+#define kPresetCount ((int)(sizeof(kPresets) / sizeof(kPresets[0])))
+
+static void loadPreset(app_state_t *s, int total) {
+    int mins = total / 60;
+    int secs = total % 60;
+    if (mins >= 10) {
+        s->digitBuf[0] = '0' + (mins / 10);
+        s->digitBuf[1] = '0' + (mins % 10);
+        s->digitLen    = 2;
+    } else {
+        s->digitBuf[0] = '0' + mins;
+        s->digitLen    = 1;
+    }
+    s->secBuf[0] = '0' + (secs / 10);
+    s->secBuf[1] = '0' + (secs % 10);
+    s->secLen    = 2;
+    s->enteringSeconds = true;
+}
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+static void clearSegs(app_state_t *s) {
+    memset(s->segs, 0, sizeof(s->segs));
+    s->segsDirty = true;
+}
+
+static int parseBuf(const char *buf, int len) {
+    if (len == 1) return buf[0] - '0';
+    if (len == 2) return (buf[0] - '0') * 10 + (buf[1] - '0');
+    return 0;
+}
+
+static int parseEntrySec(const app_state_t *s) {
+    return parseBuf(s->digitBuf, s->digitLen) * 60 +
+           parseBuf(s->secBuf,   s->secLen);
+}
+
+static void startTimerWithSec(app_state_t *s, bool up, int total, uint32_t now) {
+    s->totalSeconds = up ? 0 : total;
+    s->targetSec    = up ? total : 0;
+    s->countingUp   = up;
+    s->paused       = false;
+    s->prePos       = 0;
+    s->lastPhase    = now - 1000;
+    s->mode         = MODE_PRECOUNTDOWN;
+    s->digitLen     = 0;
+    s->secLen       = 0;
+    s->enteringSeconds = false;
+    s->overrun      = false;
+    s->lastEntrySec = total;
+    s->presetIdx    = -1;
+}
+
+static void startTimer(app_state_t *s, bool up, uint32_t now) {
+    startTimerWithSec(s, up, parseEntrySec(s), now);
+}
+
+// ---------------------------------------------------------------------------
+// Key actions
+// ---------------------------------------------------------------------------
+
+static void clearEntry(app_state_t *s) {
+    s->digitLen  = 0;
+    s->secLen    = 0;
+    s->enteringSeconds = false;
+    s->presetIdx = -1;
+}
+
+static void keyAbortPreCountdown(app_state_t *s, char key, uint32_t now) {
+    (void)now;
+    s->mode = MODE_IDLE;
+    clearEntry(s);
+    clearSegs(s);
+    s->lastKey = key;
+}
+
+static void keyTimer(app_state_t *s, char key, uint32_t now) {
+    if (key == '*' && s->lastKey == '*') {
+        s->mode    = MODE_IDLE;
+        s->paused  = false;
+        clearEntry(s);
+        s->overrun = false;
+        clearSegs(s);
+    } else {
+        s->paused = !s->paused;
+        if (!s->paused) {
+            s->lastTick  = now;
+            s->lastPhase = now;
+        }
+    }
+    s->lastKey = key;
+}
+
+static void keyIdleDigit(app_state_t *s, char key, uint32_t now) {
+    (void)now;
+    if (s->presetIdx >= 0) clearEntry(s);
+    char *buf = s->enteringSeconds ? s->secBuf  : s->digitBuf;
+    int  *len = s->enteringSeconds ? &s->secLen : &s->digitLen;
+    if (*len < 2) {
+        buf[(*len)++] = key;
+    } else {
+        buf[0] = buf[1];
+        buf[1] = key;
+    }
+}
+
+static void keyIdleSeconds(app_state_t *s, char key, uint32_t now) {
+    (void)key; (void)now;
+    if (s->presetIdx >= 0) clearEntry(s);
+    s->enteringSeconds = true;
+}
+
+static void keyIdlePresetNext(app_state_t *s, char key, uint32_t now) {
+    (void)key; (void)now;
+    s->presetIdx = (s->presetIdx + 1) % kPresetCount;
+    loadPreset(s, kPresets[s->presetIdx]);
+}
+
+static void keyIdlePresetPrev(app_state_t *s, char key, uint32_t now) {
+    (void)key; (void)now;
+    s->presetIdx = (s->presetIdx <= 0)
+        ? kPresetCount - 1
+        : s->presetIdx - 1;
+    loadPreset(s, kPresets[s->presetIdx]);
+}
+
+static void keyIdleClear(app_state_t *s, char key, uint32_t now) {
+    (void)key; (void)now;
+    clearEntry(s);
+    s->lastEntrySec = 0;
+}
+
+static void keyIdleStart(app_state_t *s, char key, uint32_t now) {
+    bool up = key == 'B';
+    if (s->digitLen >= 1 || s->secLen >= 1) {
+        startTimer(s, up, now);
+    } else if (!s->enteringSeconds && s->lastEntrySec > 0) {
+        startTimerWithSec(s, up, s->lastEntrySec, now);
+    } else {
+        keyIdleClear(s, key, now);
+    }
+}
+
+typedef void (*key_action_fn)(app_state_t *s, char key, uint32_t now);
+
+typedef struct {
+    char          key;
+    key_action_fn action;
+} key_binding_t;
+
+// IDLE key bindings; digits are handled by range, anything unlisted clears.
+static const key_binding_t kIdleKeys[] = {
+    { '#', keyIdleSeconds    },
+    { 'C', keyIdlePresetNext },
+    { 'D', keyIdlePresetPrev },
+    { 'A', keyIdleStart      },
+    { 'B', keyIdleStart      },
+};
+
+static void keyIdle(app_state_t *s, char key, uint32_t now) {
+    key_action_fn action = keyIdleClear;
+    if (key >= '0' && key <= '9') {
+        action = keyIdleDigit;
+    } else {
+        for (size_t i = 0; i < sizeof(kIdleKeys) / sizeof(kIdleKeys[0]); i++) {
+            if (kIdleKeys[i].key == key) {
+                action = kIdleKeys[i].action;
+                break;
+            }
+        }
+    }
+    action(s, key, now);
+}
+
+static const key_action_fn kModeKey[] = {
+    [MODE_IDLE]         = keyIdle,
+    [MODE_PRECOUNTDOWN] = keyAbortPreCountdown,
+    [MODE_COUNTDOWN]    = keyTimer,
+    [MODE_COUNTUP]      = keyTimer,
+};
+_Static_assert(sizeof(kModeKey) / sizeof(kModeKey[0]) == MODE_COUNT,
+               "kModeKey must cover every mode");
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+void handleKey(app_state_t *s, char key, uint32_t now) {
+    if (key == 0) return;
+    s->lastActivityTime = now;
+    s->segsDirty = true;
+
+    if ((unsigned)s->mode >= MODE_COUNT) return;
+    kModeKey[s->mode](s, key, now);
+}
@@ -1,5 +1,6 @@
 #include "app_state.h"
 #include <string.h>
+#include <limits.h>
 
 void app_state_init(app_state_t *s) {
     memset(s, 0, sizeof(*s));
@@ -10,26 +11,6 @@ void app_state_init(app_state_t *s) {
     s->presetIdx  = -1;
 }
 
-static const int kPresets[] = { 30, 60, 90, 120, 180, 300 };
-#define kPresetCount ((int)(sizeof(kPresets) / sizeof(kPresets[0])))
-
-static void loadPreset(app_state_t *s, int total) {
-    int mins = total / 60;
-    int secs = total % 60;
-    if (mins >= 10) {
-        s->digitBuf[0] = '0' + (mins / 10);
-        s->digitBuf[1] = '0' + (mins % 10);
-        s->digitLen    = 2;
-    } else {
-        s->digitBuf[0] = '0' + mins;
-        s->digitLen    = 1;
-    }
-    s->secBuf[0] = '0' + (secs / 10);
-    s->secBuf[1] = '0' + (secs % 10);
-    s->secLen    = 2;
-    s->enteringSeconds = true;
-}
-
 // ---------------------------------------------------------------------------
 // Helpers
 // ---------------------------------------------------------------------------
@@ -61,361 +42,212 @@ static void buildTimeSegments(int totalSec, bool colonOn,
     }
 }
 
-static void updateSegsFromTime(app_state_t *s) {
-    buildTimeSegments(s->totalSeconds, s->colonOn, true, s->segs);
-    s->segsDirty = true;
-}
+// ---------------------------------------------------------------------------
+// Timer core
+// ---------------------------------------------------------------------------
 
-static int parseBuf(const char *buf, int len) {
-    if (len == 1) return buf[0] - '0';
-    if (len == 2) return (buf[0] - '0') * 10 + (buf[1] - '0');
-    return 0;
+// COUNTDOWN and COUNTUP share one timer core; they differ only in tick
+// direction, whether the clock keeps running after overrun, and how the
+// remaining time is derived.
+typedef struct {
+    int  step;
+    bool holdOnOverrun;
+    int  (*remaining)(const app_state_t *s);
+} timer_dir_t;
+
+static int remainingDown(const app_state_t *s) {
+    return s->totalSeconds;
 }
 
-static int parseEntrySec(const app_state_t *s) {
-    return parseBuf(s->digitBuf, s->digitLen) * 60 +
-           parseBuf(s->secBuf,   s->secLen);
+static int remainingUp(const app_state_t *s) {
+    return s->targetSec > 0 ? s->targetSec - s->totalSeconds : INT_MAX;
 }
 
-static void startTimerWithSec(app_state_t *s, bool up, int total, uint32_t now) {
-    s->totalSeconds = up ? 0 : total;
-    s->targetSec    = up ? total : 0;
-    s->countingUp   = up;
-    s->paused       = false;
-    s->prePos       = 0;
-    s->lastPhase    = now - 1000;
-    s->mode         = MODE_PRECOUNTDOWN;
-    s->digitLen     = 0;
-    s->secLen       = 0;
-    s->enteringSeconds = false;
-    s->overrun      = false;
-    s->lastEntrySec = total;
-    s->presetIdx    = -1;
-}
+// Indexed by "counting up", so every entry is populated.
+static const timer_dir_t kTimerDirs[2] = {
+    [false] = { -1, true,  remainingDown },
+    [true]  = { +1, false, remainingUp   },
+};
 
-static void startTimer(app_state_t *s, bool up, uint32_t now) {
-    startTimerWithSec(s, up, parseEntrySec(s), now);
+static void buildTimerSegments(app_state_t *s, const timer_dir_t *dir) {
+    buildTimeSegments(s->totalSeconds, s->colonOn, true, s->segs);
+    int remain = dir->remaining(s);
+    if (s->overrun) {
+        s->segs[3] |= SEG_DP;
+    } else if (remain > 0 && remain <= 10) {
+        s->segs[3] |= SEG_DP;
+    } else if (remain <= 30 && s->colonOn) {
+        s->segs[3] |= SEG_DP;
+    }
 }
 
-// ---------------------------------------------------------------------------
-// Public API
-// ---------------------------------------------------------------------------
-
-void updateMode(app_state_t *s, uint32_t now) {
-    if (s->paused) return;
-
-    s->targetDuty = DUTY_NORMAL_VAL;
-
-    switch (s->mode) {
-
-    case MODE_PRECOUNTDOWN: {
-        static const uint8_t line[3] = { SEG_D, SEG_G, SEG_A };
-        const int walkSteps = 3;
-        const int lineSteps = 3;
-        const int totalSteps = walkSteps + lineSteps;
+static uint8_t breatheDuty(uint32_t elapsed, uint32_t period,
+                           uint8_t from, uint8_t to) {
+    uint32_t half  = period / 2;
+    uint32_t phase = elapsed % period;
+    uint32_t t1024 = (phase < half)
+        ? (phase * 1024u / half)
+        : ((period - phase) * 1024u / half);
+    int diff = (int)to - (int)from;
+    return (uint8_t)((int)from + diff * (int)t1024 / 1024);
+}
 
-        if (s->prePos < totalSteps) {
-            uint32_t gate = (s->prePos < walkSteps) ? 1000 : 250;
-            if (now - s->lastPhase < gate) break;
-            if (s->prePos < walkSteps) {
-                clearSegs(s);
-                s->segs[s->prePos] = segmentMap[3 - s->prePos];
-            } else {
-                uint8_t row = line[s->prePos - walkSteps];
-                for (int i = 0; i < kDigits; i++) {
-                    s->segs[i] = row;
-                }
-            }
-            s->segsDirty = true;
-            s->prePos++;
-            s->lastPhase = now;
-        } else {
-            if (now - s->lastPhase < 250) break;
-            s->lastTick = now;
-            s->colonOn  = true;
-            s->mode     = s->countingUp ? MODE_COUNTUP : MODE_COUNTDOWN;
-            buildTimeSegments(s->totalSeconds, s->colonOn, true, s->segs);
-            s->segsDirty = true;
-        }
-        break;
-    }
+static void updateTimer(app_state_t *s, uint32_t now) {
+    const timer_dir_t *dir = &kTimerDirs[s->mode == MODE_COUNTUP];
 
-    case MODE_COUNTDOWN: {
-        bool tick = (now - s->lastTick) >= 1000;
-        if (tick && !s->overrun) {
-            s->lastTick += 1000;
+    bool tick = (now - s->lastTick) >= 1000;
+    if (tick) {
+        s->lastTick += 1000;
+        if (!(s->overrun && dir->holdOnOverrun)) {
             s->colonOn = !s->colonOn;
-            tickTime(s, -1);
-        } else if (tick) {
-            s->lastTick += 1000;
-        }
-        if (!s->overrun && s->totalSeconds <= 0) {
-            s->totalSeconds = 0;
-            s->overrun   = true;
-            s->overrunAt = now;
-            s->flashOn   = true;
+            tickTime(s, dir->step);
         }
-        bool alerting = s->overrun && (now - s->overrunAt) < 2000;
-        if (alerting) {
-            bool show = (((now - s->overrunAt) / 250) % 2) == 0;
-            if (show != s->flashOn || tick) {
-                s->flashOn = show;
-                if (show) {
-                    buildTimeSegments(s->totalSeconds, s->colonOn, true, s->segs);
-                    s->segs[3] |= SEG_DP;
-                } else {
-                    memset(s->segs, 0, sizeof(s->segs));
-                }
-                s->segsDirty = true;
-            }
-        } else if (tick || (s->overrun && !s->flashOn)) {
-            buildTimeSegments(s->totalSeconds, s->colonOn, true, s->segs);
-            if (s->overrun) {
-                s->segs[3] |= SEG_DP;
-            } else if (s->totalSeconds > 0 && s->totalSeconds <= 10) {
-                s->segs[3] |= SEG_DP;
-            } else if (s->totalSeconds <= 30 && s->colonOn) {
-                s->segs[3] |= SEG_DP;
-            }
-            s->flashOn = true;
-            s->segsDirty = true;
-        }
-        if (s->overrun && !alerting) {
-            uint32_t phase = (now - s->overrunAt - 2000u) % 3000u;
-            uint32_t t1024 = (phase < 1500u)
-                ? (phase * 1024u / 1500u)
-                : ((3000u - phase) * 1024u / 1500u);
-            int diff = (int)DUTY_DIMMED_VAL - (int)DUTY_NORMAL_VAL;
-            s->targetDuty = (uint8_t)((int)DUTY_NORMAL_VAL +
-                                      diff * (int)t1024 / 1024);
-        }
-        break;
     }
-
-    case MODE_COUNTUP: {
-        bool tick = (now - s->lastTick) >= 1000;
-        if (tick) {
-            s->lastTick += 1000;
-            s->colonOn = !s->colonOn;
-            tickTime(s, +1);
-        }
-        if (!s->overrun && s->targetSec > 0 &&
-            s->totalSeconds >= s->targetSec) {
-            s->overrun   = true;
-            s->overrunAt = now;
-            s->flashOn   = true;
-        }
-        bool alerting = s->overrun && (now - s->overrunAt) < 2000;
-        if (alerting) {
-            bool show = (((now - s->overrunAt) / 250) % 2) == 0;
-            if (show != s->flashOn || tick) {
-                s->flashOn = show;
-                if (show) {
-                    buildTimeSegments(s->totalSeconds, s->colonOn, true, s->segs);
-                    s->segs[3] |= SEG_DP;
-                } else {
-                    memset(s->segs, 0, sizeof(s->segs));
-                }
-                s->segsDirty = true;
-            }
-        } else if (tick || (s->overrun && !s->flashOn)) {
-            buildTimeSegments(s->totalSeconds, s->colonOn, true, s->segs);
-            if (s->overrun) {
-                s->segs[3] |= SEG_DP;
-            } else if (s->targetSec > 0) {
-                int remain = s->targetSec - s->totalSeconds;
-                if (remain > 0 && remain <= 10) {
-                    s->segs[3] |= SEG_DP;
-                } else if (remain <= 30 && s->colonOn) {
-                    s->segs[3] |= SEG_DP;
-                }
-            }
-            s->flashOn = true;
-            s->segsDirty = true;
-        }
-        if (s->overrun && !alerting) {
-            uint32_t phase = (now - s->overrunAt - 2000u) % 3000u;
-            uint32_t t1024 = (phase < 1500u)
-                ? (phase * 1024u / 1500u)
-                : ((3000u - phase) * 1024u / 1500u);
-            int diff = (int)DUTY_DIMMED_VAL - (int)DUTY_NORMAL_VAL;
-            s->targetDuty = (uint8_t)((int)DUTY_NORMAL_VAL +
-                                      diff * (int)t1024 / 1024);
-        }
-        break;
+    if (!s->overrun && dir->remaining(s) <= 0) {
+        s->overrun   = true;
+        s->overrunAt = now;
+        s->flashOn   = true;
     }
-
-    case MODE_IDLE: {
-        if (s->segsDirty) s->blinkBase = now;
-        uint32_t idleElapsed = now - s->lastActivityTime;
-        bool hasInput = s->digitLen > 0 || s->secLen > 0 || s->enteringSeconds;
-        bool sleeping = !hasInput && idleElapsed >= IDLE_SLEEP_MS;
-        bool ghost = !hasInput && !sleeping && s->lastEntrySec > 0;
-        bool quiet = !hasInput && !ghost && idleElapsed >= IDLE_DIM_MS;
-
-        if (sleeping) {
-            uint32_t phase = (idleElapsed - IDLE_SLEEP_MS) % 4000u;
-            uint32_t t1024 = (phase < 2000u)
-                ? (phase * 1024u / 2000u)
-                : ((4000u - phase) * 1024u / 2000u);
-            int diff = (int)DUTY_FAINT_VAL - 255;
-            s->targetDuty = (uint8_t)(255 + diff * (int)t1024 / 1024);
-            if (s->lastBlink || s->segsDirty) {
-                s->lastBlink = false;
-                memset(s->segs, 0, sizeof(s->segs));
-                s->segs[1] = SEG_D;
-                s->segsDirty = true;
-            }
-        } else if (ghost) {
-            s->targetDuty = DUTY_DIMMED_VAL;
-            if (s->lastBlink || s->segsDirty) {
-                s->lastBlink = false;
-                buildTimeSegments(s->lastEntrySec, true, true, s->segs);
-                s->segsDirty = true;
-            }
-        } else if (quiet) {
-            s->targetDuty = DUTY_DIMMED_VAL;
-            if (s->lastBlink || s->segsDirty) {
-                s->lastBlink = false;
-                memset(s->segs, 0, sizeof(s->segs));
-                s->segs[1] = SEG_D;
-                s->segsDirty = true;
-            }
-        } else if (s->presetIdx >= 0) {
-            if (s->lastBlink || s->segsDirty) {
-                s->lastBlink = false;
-                memset(s->segs, 0, sizeof(s->segs));
-                int offset = 2 - s->digitLen;
-                for (int i = 0; i < s->digitLen; i++) {
-                    s->segs[offset + i] = segmentMap[s->digitBuf[i] - '0'];
-                }
-                for (int i = 0; i < s->secLen; i++) {
-                    s->segs[2 + i] = segmentMap[s->secBuf[i] - '0'];
-                }
-                if (s->enteringSeconds) {
-                    s->segs[1] |= SEG_DP;
-                    s->segs[2] |= SEG_DP;
-                }
-                s->segsDirty = true;
-            }
-        } else {
-            bool blinkOn = ((now - s->blinkBase) / 500) % 2 == 0;
-            if (blinkOn != s->lastBlink || s->segsDirty) {
-                s->lastBlink = blinkOn;
+    bool alerting = s->overrun && (now - s->overrunAt) < 2000;
+    if (alerting) {
+        bool show = (((now - s->overrunAt) / 250) % 2) == 0;
+        if (show != s->flashOn || tick) {
+            s->flashOn = show;
+            if (show) {
+                buildTimeSegments(s->totalSeconds, s->colonOn, true, s->segs);
+                s->segs[3] |= SEG_DP;
+            } else {
                 memset(s->segs, 0, sizeof(s->segs));
-                if (!hasInput) {
-                    if (blinkOn) s->segs[1] = SEG_D;
-                } else if (blinkOn) {
-                    int offset = 2 - s->digitLen;
-                    for (int i = 0; i < s->digitLen; i++) {
-                        s->segs[offset + i] = segmentMap[s->digitBuf[i] - '0'];
-                    }
-                    for (int i = 0; i < s->secLen; i++) {
-                        s->segs[2 + i] = segmentMap[s->secBuf[i] - '0'];
-                    }
-                    if (s->enteringSeconds) {
-                        s->segs[1] |= SEG_DP;
-                        s->segs[2] |= SEG_DP;
-                    }
-                }
-                s->segsDirty = true;
             }
+            s->segsDirty = true;
         }
-        break;
+    } else if (tick || (s->overrun && !s->flashOn)) {
+        buildTimerSegments(s, dir);
+        s->flashOn = true;
+        s->segsDirty = true;
     }
-
-    default:
-        break;
+    if (s->overrun && !alerting) {
+        s->targetDuty = breatheDuty(now - s->overrunAt - 2000u, 3000u,
+                                    DUTY_NORMAL_VAL, DUTY_DIMMED_VAL);
     }
 }
 
-void handleKey(app_state_t *s, char key, uint32_t now) {
-    if (key == 0) return;
-    s->lastActivityTime = now;
-    s->segsDirty = true;
-
-    switch (s->mode) {
+// ---------------------------------------------------------------------------
+// Mode updates
+// ---------------------------------------------------------------------------
 
-    case MODE_PRECOUNTDOWN:
-        s->mode     = MODE_IDLE;
-        s->digitLen = 0;
-        s->secLen   = 0;
-        s->enteringSeconds = false;
-        s->presetIdx = -1;
-        clearSegs(s);
-        s->lastKey = key;
-        return;
+static void updatePreCountdown(app_state_t *s, uint32_t now) {
+    static const uint8_t line[3] = { SEG_D, SEG_G, SEG_A };
+    const int walkSteps = 3;
+    const int lineSteps = 3;
+    const int totalSteps = walkSteps + lineSteps;
 
-    case MODE_COUNTDOWN:
-    case MODE_COUNTUP:
-        if (key == '*' && s->lastKey == '*') {
-            s->mode     = MODE_IDLE;
-            s->paused   = false;
-            s->digitLen = 0;
-            s->secLen   = 0;
-            s->enteringSeconds = false;
-            s->presetIdx = -1;
-            s->overrun  = false;
+    if (s->prePos < totalSteps) {
+        uint32_t gate = (s->prePos < walkSteps) ? 1000 : 250;
+        if (now - s->lastPhase < gate) return;
+        if (s->prePos < walkSteps) {
             clearSegs(s);
+            s->segs[s->prePos] = segmentMap[3 - s->prePos];
         } else {
-            s->paused = !s->paused;
-            if (!s->paused) {
-                s->lastTick  = now;
-                s->lastPhase = now;
+            uint8_t row = line[s->prePos - walkSteps];
+            for (int i = 0; i < kDigits; i++) {
+                s->segs[i] = row;
             }
         }
-        s->lastKey = key;
-        return;
+        s->segsDirty = true;
+        s->prePos++;
+        s->lastPhase = now;
+    } else {
+        if (now - s->lastPhase < 250) return;
+        s->lastTick = now;
+        s->colonOn  = true;
+        s->mode     = s->countingUp ? MODE_COUNTUP : MODE_COUNTDOWN;
+        buildTimeSegments(s->totalSeconds, s->colonOn, true, s->segs);
+        s->segsDirty = true;
+    }
+}
 
-    case MODE_IDLE:
-        if (key >= '0' && key <= '9') {
-            if (s->presetIdx >= 0) {
-                s->digitLen = 0;
-                s->secLen   = 0;
-                s->enteringSeconds = false;
-                s->presetIdx = -1;
-            }
-            char *buf = s->enteringSeconds ? s->secBuf  : s->digitBuf;
-            int  *len = s->enteringSeconds ? &s->secLen : &s->digitLen;
-            if (*len < 2) {
-                buf[(*len)++] = key;
-            } else {
-                buf[0] = buf[1];
-                buf[1] = key;
-            }
-            s->segsDirty = true;
-        } else if (key == '#') {
-            if (s->presetIdx >= 0) {
-                s->digitLen = 0;
-                s->secLen   = 0;
-                s->presetIdx = -1;
-            }
-            s->enteringSeconds = true;
+static void buildEntrySegments(app_state_t *s) {
+    int offset = 2 - s->digitLen;
+    for (int i = 0; i < s->digitLen; i++) {
+        s->segs[offset + i] = segmentMap[s->digitBuf[i] - '0'];
+    }
+    for (int i = 0; i < s->secLen; i++) {
+        s->segs[2 + i] = segmentMap[s->secBuf[i] - '0'];
+    }
+    if (s->enteringSeconds) {
+        s->segs[1] |= SEG_DP;
+        s->segs[2] |= SEG_DP;
+    }
+}
+
+static void updateIdle(app_state_t *s, uint32_t now) {
+    if (s->segsDirty) s->blinkBase = now;
+    uint32_t idleElapsed = now - s->lastActivityTime;
+    bool hasInput = s->digitLen > 0 || s->secLen > 0 || s->enteringSeconds;
+    bool sleeping = !hasInput && idleElapsed >= IDLE_SLEEP_MS;
+    bool ghost = !hasInput && !sleeping && s->lastEntrySec > 0;
+    bool quiet = !hasInput && !ghost && idleElapsed >= IDLE_DIM_MS;
+
+    if (sleeping || quiet) {
+        s->targetDuty = sleeping
+            ? breatheDuty(idleElapsed - IDLE_SLEEP_MS, 4000u,
+                          255, DUTY_FAINT_VAL)
+            : DUTY_DIMMED_VAL;
+        if (s->lastBlink || s->segsDirty) {
+            s->lastBlink = false;
+            memset(s->segs, 0, sizeof(s->segs));
+            s->segs[1] = SEG_D;
             s->segsDirty = true;
-        } else if (key == 'C') {
-            s->presetIdx = (s->presetIdx + 1) % kPresetCount;
-            loadPreset(s, kPresets[s->presetIdx]);
+        }
+    } else if (ghost) {
+        s->targetDuty = DUTY_DIMMED_VAL;
+        if (s->lastBlink || s->segsDirty) {
+            s->lastBlink = false;
+            buildTimeSegments(s->lastEntrySec, true, true, s->segs);
             s->segsDirty = true;
-        } else if (key == 'D') {
-            s->presetIdx = (s->presetIdx <= 0)
-                ? kPresetCount - 1
-                : s->presetIdx - 1;
-            loadPreset(s, kPresets[s->presetIdx]);
+        }
+    } else if (s->presetIdx >= 0) {
+        if (s->lastBlink || s->segsDirty) {
+            s->lastBlink = false;
+            memset(s->segs, 0, sizeof(s->segs));
+            buildEntrySegments(s);
             s->segsDirty = true;
-        } else if ((key == 'A' || key == 'B') &&
-                   (s->digitLen >= 1 || s->secLen >= 1)) {
-            startTimer(s, key == 'B', now);
-        } else if ((key == 'A' || key == 'B') &&
-                   !s->enteringSeconds && s->lastEntrySec > 0) {
-            startTimerWithSec(s, key == 'B', s->lastEntrySec, now);
-        } else {
-            s->digitLen  = 0;
-            s->secLen    = 0;
-            s->enteringSeconds = false;
-            s->lastEntrySec = 0;
-            s->presetIdx = -1;
+        }
+    } else {
+        bool blinkOn = ((now - s->blinkBase) / 500) % 2 == 0;
+        if (blinkOn != s->lastBlink || s->segsDirty) {
+            s->lastBlink = blinkOn;
+            memset(s->segs, 0, sizeof(s->segs));
+            if (!hasInput) {
+                if (blinkOn) s->segs[1] = SEG_D;
+            } else if (blinkOn) {
+                buildEntrySegments(s);
+            }
             s->segsDirty = true;
         }
-        break;
     }
 }
+
+typedef void (*mode_update_fn)(app_state_t *s, uint32_t now);
+
+static const mode_update_fn kModeUpdate[] = {
+    [MODE_IDLE]         = updateIdle,
+    [MODE_PRECOUNTDOWN] = updatePreCountdown,
+    [MODE_COUNTDOWN]    = updateTimer,
+    [MODE_COUNTUP]      = updateTimer,
+};
+_Static_assert(sizeof(kModeUpdate) / sizeof(kModeUpdate[0]) == MODE_COUNT,
+               "kModeUpdate must cover every mode");
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+
+void updateMode(app_state_t *s, uint32_t now) {
+    if (s->paused) return;
+
+    s->targetDuty = DUTY_NORMAL_VAL;
+    if ((unsigned)s->mode >= MODE_COUNT) return;
+    kModeUpdate[s->mode](s, now);
+}
@@ -17,7 +17,8 @@ typedef enum {
     MODE_IDLE,
     MODE_PRECOUNTDOWN,
     MODE_COUNTDOWN,
-    MODE_COUNTUP
+    MODE_COUNTUP,
+    MODE_COUNT
 } mode_t;
 
 typedef struct {
@@ -0,0 +1,212 @@
+#include "display.h"
+#include "driver/gpio.h"
+#include "driver/ledc.h"
+#include "hal/gpio_ll.h"
+#include "hal/ledc_ll.h"
+#include "soc/gpio_struct.h"
+#include "soc/ledc_struct.h"
+#include "soc/io_mux_reg.h"
+#include "soc/gpio_periph.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
+#include "esp_check.h"
+
+// Pin mapping
+#define TPIC_DATA   GPIO_NUM_3
+#define TPIC_CLOCK  GPIO_NUM_0
+#define TPIC_LATCH  GPIO_NUM_1
+#define TPIC_G      GPIO_NUM_4
+
+#define PWM_FREQ_HZ 5000
+
+// Digit at position 2 is physically mounted upside-down on the PCB.
+#define FLIP_MASK 0b0100
+
+// display_show() and display_set_brightness() run from the tick interrupt
+// and are placed in IRAM by linker.lf (see CONFIG_TPIC_RT_PLACEMENT), so they
+// only use ROM delays and the inline GPIO/LEDC LL helpers. display_init() and
+// display_get_stats() are task-only and stay in flash.
+
+// The TPIC shift register is the back buffer and its storage register the
+// front buffer: display_show() shifts a frame in and then requests a latch.
+// With CONFIG_TPIC_LATCH_SYNC the latch edge is deferred to the PWM
+// off-window, i.e. while /G is high (hpoint = 0, active low), so a frame
+// never changes while the outputs are driven. Latest frame wins: a frame
+// shifted in before the previous one latched replaces it, and the producer
+// never waits for the PWM cycle.
+static bool    s_latchPending;
+static int64_t s_requestedAt;
+static uint8_t s_duty;
+static int     s_isrCore;
+static display_stats_t s_stats;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static uint8_t rotate180(uint8_t v) {
+    uint8_t out = 0;
+    if (v & SEG_A)  out |= SEG_D;
+    if (v & SEG_B)  out |= SEG_E;
+    if (v & SEG_C)  out |= SEG_F;
+    if (v & SEG_D)  out |= SEG_A;
+    if (v & SEG_E)  out |= SEG_B;
+    if (v & SEG_F)  out |= SEG_C;
+    if (v & SEG_G)  out |= SEG_G;
+    if (v & SEG_DP) out |= SEG_DP;
+    return out;
+}
+
+static void shift_out(uint8_t data) {
+    for (int i = 7; i >= 0; i--) {
+        gpio_ll_set_level(&GPIO, TPIC_DATA, (data >> i) & 1);
+        esp_rom_delay_us(1);
+        gpio_ll_set_level(&GPIO, TPIC_CLOCK, 1);
+        esp_rom_delay_us(1);
+        gpio_ll_set_level(&GPIO, TPIC_CLOCK, 0);
+    }
+}
+
+// True when /G stays high long enough per PWM period for the latch
+// interrupt to land inside it; otherwise latch immediately.
+static bool has_off_window(uint8_t duty) {
+#if CONFIG_TPIC_LATCH_SYNC
+    uint32_t window_us = (uint32_t)duty * 1000000u / (PWM_FREQ_HZ * 256u);
+    return window_us >= CONFIG_TPIC_LATCH_MIN_WINDOW_US;
+#else
+    (void)duty;
+    return false;
+#endif
+}
+
+// Caller holds s_lock. Also used by the latch interrupt, hence IRAM.
+static void IRAM_ATTR latch_now(void) {
+    gpio_ll_set_level(&GPIO, TPIC_LATCH, 1);
+    if (s_latchPending) {
+        gpio_ll_intr_disable(&GPIO, TPIC_G);
+        s_latchPending = false;
+    }
+}
+
+static void IRAM_ATTR display_latch_isr(void *arg) {
+    (void)arg;
+    portENTER_CRITICAL_ISR(&s_lock);
+    if (s_latchPending) {
+        if (gpio_ll_get_level(&GPIO, TPIC_G)) {
+            latch_now();
+            uint32_t latency = (uint32_t)(esp_timer_get_time() - s_requestedAt);
+            if (latency > s_stats.max_latency_us) s_stats.max_latency_us = latency;
+            s_stats.deferred++;
+        } else {
+            // The window closed before we got here; stay armed for the next.
+            s_stats.late++;
+        }
+    }
+    portEXIT_CRITICAL_ISR(&s_lock);
+}
+
+void display_show(const uint8_t segs[kDigits]) {
+    // Drop a frame that is still waiting for its latch; it is overwritten
+    // in the shift register below and must not latch half-shifted.
+    portENTER_CRITICAL_SAFE(&s_lock);
+    if (s_latchPending) {
+        gpio_ll_intr_disable(&GPIO, TPIC_G);
+        s_latchPending = false;
+        s_stats.superseded++;
+    }
+    portEXIT_CRITICAL_SAFE(&s_lock);
+
+    gpio_ll_set_level(&GPIO, TPIC_LATCH, 0);
+    for (int pos = kDigits - 1; pos >= 0; pos--) {
+        uint8_t out = segs[pos];
+        if (FLIP_MASK & (1 << pos)) {
+            out = rotate180(out);
+        }
+        shift_out(out);
+    }
+
+    portENTER_CRITICAL_SAFE(&s_lock);
+    if (has_off_window(s_duty)) {
+        s_latchPending = true;
+        s_requestedAt  = esp_timer_get_time();
+        // Discard an edge seen while disarmed so the latch waits for the
+        // next off-window rather than firing immediately.
+        gpio_ll_clear_intr_status_bit(&GPIO, TPIC_G);
+        gpio_ll_intr_enable_on_core(&GPIO, s_isrCore, TPIC_G);
+    } else {
+        latch_now();
+        s_stats.immediate++;
+    }
+    portEXIT_CRITICAL_SAFE(&s_lock);
+}
+
+void display_get_stats(display_stats_t *out) {
+    portENTER_CRITICAL(&s_lock);
+    *out = s_stats;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void display_set_brightness(uint8_t duty) {
+    portENTER_CRITICAL_SAFE(&s_lock);
+    if (duty != s_duty) {
+        s_duty = duty;
+        // Same register sequence as ledc_set_duty() + ledc_update_duty(); the
+        // fade parameters set up by ledc_channel_config() are left as they are.
+        ledc_ll_set_duty_int_part(&LEDC, LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0, duty);
+        ledc_ll_set_duty_start(&LEDC, LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0, true);
+        ledc_ll_ls_channel_update(&LEDC, LEDC_LOW_SPEED_MODE, LEDC_CHANNEL_0);
+        // A pending frame would never latch if the off-window just went away.
+        if (s_latchPending && !has_off_window(duty)) {
+            latch_now();
+            s_stats.immediate++;
+        }
+    }
+    portEXIT_CRITICAL_SAFE(&s_lock);
+}
+
+void display_init(uint8_t duty) {
+    // Configure TPIC shift register pins
+    gpio_config_t tpic_cfg = {
+        .pin_bit_mask = (1ULL << TPIC_DATA) | (1ULL << TPIC_CLOCK) | (1ULL << TPIC_LATCH),
+        .mode = GPIO_MODE_OUTPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE,
+    };
+    ESP_ERROR_CHECK(gpio_config(&tpic_cfg));
+
+    // PWM brightness on /G pin
+    ledc_timer_config_t ledc_timer = {
+        .speed_mode = LEDC_LOW_SPEED_MODE,
+        .duty_resolution = LEDC_TIMER_8_BIT,
+        .timer_num = LEDC_TIMER_0,
+        .freq_hz = PWM_FREQ_HZ,
+        .clk_cfg = LEDC_AUTO_CLK,
+    };
+    ESP_ERROR_CHECK(ledc_timer_config(&ledc_timer));
+
+    ledc_channel_config_t ledc_channel = {
+        .gpio_num = TPIC_G,
+        .speed_mode = LEDC_LOW_SPEED_MODE,
+        .channel = LEDC_CHANNEL_0,
+        .intr_type = LEDC_INTR_DISABLE,
+        .timer_sel = LEDC_TIMER_0,
+        .duty = duty,
+        .hpoint = 0,
+    };
+    ESP_ERROR_CHECK(ledc_channel_config(&ledc_channel));
+    portENTER_CRITICAL(&s_lock);
+    s_duty = duty;
+    portEXIT_CRITICAL(&s_lock);
+
+    // Watch /G itself for the start of the off-window. The pad stays routed
+    // to LEDC; only its input buffer is enabled so the edge can be seen.
+    // The interrupt is enabled per frame, only while a latch is pending.
+    // The GPIO ISR service dispatches on the core it was installed from
+    // (app_main); route the latch interrupt there, whichever core later
+    // calls display_show().
+    s_isrCore = xPortGetCoreID();
+    PIN_INPUT_ENABLE(GPIO_PIN_MUX_REG[TPIC_G]);
+    ESP_ERROR_CHECK(gpio_set_intr_type(TPIC_G, GPIO_INTR_POSEDGE));
+    ESP_ERROR_CHECK(gpio_isr_handler_add(TPIC_G, display_latch_isr, NULL));
+    ESP_ERROR_CHECK(gpio_intr_disable(TPIC_G));
+}
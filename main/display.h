@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdint.h>
+#include "segment_defs.h"
+
+typedef struct {
+    uint32_t deferred;        // latched by the /G off-window interrupt
+    uint32_t immediate;       // latched directly (sync off or window too short)
+    uint32_t superseded;      // pending frames replaced before they latched
+    uint32_t late;            // interrupts that arrived after /G fell again
+    uint32_t max_latency_us;  // worst observed request-to-latch delay
+} display_stats_t;
+
+// Call on the core that installed the GPIO ISR service.
+void display_init(uint8_t duty);
+void display_show(const uint8_t segs[kDigits]);
+void display_set_brightness(uint8_t duty);
+void display_get_stats(display_stats_t *out);
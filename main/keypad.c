@@ -77,7 +77,6 @@ void keypad_init(keypad_t *kp, i2c_master_bus_handle_t bus, uint8_t int_pin) {
         .intr_type = GPIO_INTR_NEGEDGE,
     };
     ESP_ERROR_CHECK(gpio_config(&io_cfg));
-    ESP_ERROR_CHECK(gpio_install_isr_service(0));
     ESP_ERROR_CHECK(gpio_isr_handler_add(int_pin, keypad_isr, NULL));
 
     pcf_write(kp, 0xFF);
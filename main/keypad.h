@@ -11,5 +11,7 @@ typedef struct {
     uint32_t last_change;
 } keypad_t;
 
+// Requires the GPIO ISR service to be installed already
+// (gpio_install_isr_service(), done once in app_main).
 void keypad_init(keypad_t *kp, i2c_master_bus_handle_t bus, uint8_t int_pin);
 char keypad_poll(keypad_t *kp);
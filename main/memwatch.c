@@ -0,0 +1,140 @@
+#include "memwatch.h"
+#include <stdlib.h>
+#include "esp_heap_caps.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+
+#define MAX_WATCHED_TASKS  4
+#define MAX_INIT_STEPS     8
+#define REPORT_STACK_SIZE  3072
+
+static const char *TAG = "memwatch";
+
+static TaskHandle_t s_tasks[MAX_WATCHED_TASKS];
+static int          s_taskCount;
+
+typedef struct {
+    const char *name;
+    int         used;       // bytes of default heap taken by the step
+    uint32_t    freeAfter;
+} init_step_t;
+
+static init_step_t s_steps[MAX_INIT_STEPS];
+static int         s_stepCount;
+static uint32_t    s_lastFree;
+
+static volatile bool     s_sealed;
+static volatile uint32_t s_allocs;
+static volatile uint32_t s_allocBytes;
+static volatile uint32_t s_frees;
+
+#if CONFIG_TPIC_MEM_REPORT_INTERVAL_S > 0
+// Runtime objects are allocated statically so the heap is never touched
+// after init; see memwatch_seal().
+static StaticTask_t s_reportTcb;
+static StackType_t  s_reportStack[REPORT_STACK_SIZE];
+#endif
+
+#if CONFIG_TPIC_HEAP_GUARD
+// Heap hooks run inside malloc/free, possibly with the flash cache off.
+void IRAM_ATTR esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps) {
+    (void)caps;
+    if (!ptr || !__atomic_load_n(&s_sealed, __ATOMIC_ACQUIRE)) return;
+    __atomic_fetch_add(&s_allocs, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&s_allocBytes, (uint32_t)size, __ATOMIC_RELAXED);
+#if CONFIG_TPIC_HEAP_GUARD_ABORT
+    esp_rom_printf("memwatch: %u byte heap allocation after init\n", (unsigned)size);
+    abort();
+#endif
+}
+
+void IRAM_ATTR esp_heap_trace_free_hook(void *ptr) {
+    if (!ptr || !__atomic_load_n(&s_sealed, __ATOMIC_ACQUIRE)) return;
+    __atomic_fetch_add(&s_frees, 1, __ATOMIC_RELAXED);
+}
+#endif
+
+void memwatch_watch_task(TaskHandle_t task) {
+    if (s_taskCount < MAX_WATCHED_TASKS) {
+        s_tasks[s_taskCount++] = task;
+    }
+}
+
+void memwatch_init(void) {
+    s_lastFree = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+}
+
+void memwatch_mark(const char *name) {
+    uint32_t freeNow = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+    if (s_stepCount < MAX_INIT_STEPS) {
+        s_steps[s_stepCount++] = (init_step_t){
+            .name = name,
+            .used = (int)s_lastFree - (int)freeNow,
+            .freeAfter = freeNow,
+        };
+    }
+    s_lastFree = freeNow;
+}
+
+uint32_t memwatch_post_init_allocs(void) {
+    return __atomic_load_n(&s_allocs, __ATOMIC_RELAXED);
+}
+
+uint32_t memwatch_post_init_frees(void) {
+    return __atomic_load_n(&s_frees, __ATOMIC_RELAXED);
+}
+
+static void report_heap(const char *name, uint32_t caps) {
+    if (heap_caps_get_total_size(caps) == 0) return;
+    ESP_LOGI(TAG, "heap %-8s free %6u  min %6u  largest %6u",
+             name,
+             (unsigned)heap_caps_get_free_size(caps),
+             (unsigned)heap_caps_get_minimum_free_size(caps),
+             (unsigned)heap_caps_get_largest_free_block(caps));
+}
+
+void memwatch_report(void) {
+    report_heap("internal", MALLOC_CAP_INTERNAL);
+    report_heap("dma",      MALLOC_CAP_DMA);
+    report_heap("spiram",   MALLOC_CAP_SPIRAM);
+    for (int i = 0; i < s_stepCount; i++) {
+        ESP_LOGI(TAG, "init %-12s used %6d  free after %6u",
+                 s_steps[i].name, s_steps[i].used,
+                 (unsigned)s_steps[i].freeAfter);
+    }
+    for (int i = 0; i < s_taskCount; i++) {
+        ESP_LOGI(TAG, "stack %-16s unused %5u bytes",
+                 pcTaskGetName(s_tasks[i]),
+                 (unsigned)uxTaskGetStackHighWaterMark(s_tasks[i]));
+    }
+    ESP_LOGI(TAG, "post-init heap: %lu allocs (%lu bytes), %lu frees",
+             (unsigned long)memwatch_post_init_allocs(),
+             (unsigned long)__atomic_load_n(&s_allocBytes, __ATOMIC_RELAXED),
+             (unsigned long)memwatch_post_init_frees());
+}
+
+#if CONFIG_TPIC_MEM_REPORT_INTERVAL_S > 0
+static void report_task(void *arg) {
+    (void)arg;
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_TPIC_MEM_REPORT_INTERVAL_S * 1000u));
+        memwatch_report();
+    }
+}
+#endif
+
+void memwatch_seal(void) {
+    memwatch_watch_task(xTaskGetCurrentTaskHandle());
+
+#if CONFIG_TPIC_MEM_REPORT_INTERVAL_S > 0
+    TaskHandle_t report = xTaskCreateStatic(report_task, "memwatch",
+                                            REPORT_STACK_SIZE, NULL, 1,
+                                            s_reportStack, &s_reportTcb);
+    memwatch_watch_task(report);
+#endif
+
+    // The baseline report also primes stdout/log buffers before sealing.
+    memwatch_report();
+    __atomic_store_n(&s_sealed, true, __ATOMIC_RELEASE);
+}
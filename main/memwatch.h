@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Start attributing heap use to init steps; call first thing in app_main.
+void memwatch_init(void);
+
+// Record the default-heap bytes taken since the previous mark (or
+// memwatch_init()) under `name`, which must outlive the program.
+void memwatch_mark(const char *name);
+
+// Add a task to the stack high-water mark report.
+void memwatch_watch_task(TaskHandle_t task);
+
+// End of init: print a baseline report, start counting (or rejecting) heap
+// allocations, and start the periodic report task.
+void memwatch_seal(void);
+
+// Heap allocations/frees seen since memwatch_seal().
+uint32_t memwatch_post_init_allocs(void);
+uint32_t memwatch_post_init_frees(void);
+
+void memwatch_report(void);
@@ -0,0 +1,94 @@
+#include "ticker.h"
+#include <string.h>
+#include "driver/gptimer.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
+#include "esp_check.h"
+#include "display.h"
+#include "utils.h"
+
+static app_state_t   *s_state;
+static ticker_stats_t s_stats;
+static int64_t        s_lastTickAt;
+static portMUX_TYPE   s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// With CONFIG_TPIC_RT_PLACEMENT_IRAM this interrupt stays enabled while the
+// flash cache is off, so everything it calls is placed by linker.lf.
+static bool IRAM_ATTR ticker_isr(gptimer_handle_t timer,
+                                 const gptimer_alarm_event_data_t *edata,
+                                 void *arg) {
+    (void)timer; (void)edata; (void)arg;
+    int64_t at = esp_timer_get_time();
+    uint8_t segs[kDigits];
+
+    // Only the state update runs under the lock; the bit-banged frame output
+    // happens after it so other interrupts are not masked for ~70 us.
+    portENTER_CRITICAL_ISR(&s_lock);
+    if (s_lastTickAt != 0) {
+        uint32_t gap = (uint32_t)(at - s_lastTickAt);
+        if (gap > s_stats.max_gap_us) s_stats.max_gap_us = gap;
+    }
+    s_lastTickAt = at;
+    s_stats.ticks++;
+
+    updateMode(s_state, millis_now());
+    uint8_t duty  = s_state->paused ? DUTY_DIMMED_VAL : s_state->targetDuty;
+    bool    dirty = s_state->segsDirty;
+    if (dirty) {
+        memcpy(segs, s_state->segs, sizeof(segs));
+        s_state->segsDirty = false;
+    }
+    portEXIT_CRITICAL_ISR(&s_lock);
+
+    display_set_brightness(duty);
+    if (dirty) display_show(segs);
+    return false;
+}
+
+void ticker_lock(void) {
+    portENTER_CRITICAL(&s_lock);
+}
+
+void ticker_unlock(void) {
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void ticker_get_stats(ticker_stats_t *out) {
+    portENTER_CRITICAL(&s_lock);
+    *out = s_stats;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void ticker_reset_stats(void) {
+    portENTER_CRITICAL(&s_lock);
+    s_stats.ticks = 0;
+    s_stats.max_gap_us = 0;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void ticker_start(app_state_t *s) {
+    s_state = s;
+
+    gptimer_handle_t timer;
+    gptimer_config_t timer_cfg = {
+        .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+        .direction = GPTIMER_COUNT_UP,
+        .resolution_hz = 1000000,
+    };
+    ESP_ERROR_CHECK(gptimer_new_timer(&timer_cfg, &timer));
+
+    gptimer_event_callbacks_t cbs = {
+        .on_alarm = ticker_isr,
+    };
+    ESP_ERROR_CHECK(gptimer_register_event_callbacks(timer, &cbs, NULL));
+
+    gptimer_alarm_config_t alarm_cfg = {
+        .alarm_count = TICKER_PERIOD_US,
+        .reload_count = 0,
+        .flags.auto_reload_on_alarm = true,
+    };
+    ESP_ERROR_CHECK(gptimer_set_alarm_action(timer, &alarm_cfg));
+    ESP_ERROR_CHECK(gptimer_enable(timer));
+    ESP_ERROR_CHECK(gptimer_start(timer));
+}
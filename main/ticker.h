@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdint.h>
+#include "app_state.h"
+
+// Same cadence as the old vTaskDelay(1) main loop at the default 100 Hz.
+#define TICKER_PERIOD_US 10000
+
+typedef struct {
+    uint32_t ticks;
+    uint32_t max_gap_us;  // longest interval seen between two ticks
+} ticker_stats_t;
+
+// Runs updateMode(), brightness and frame output for *s from a periodic
+// timer interrupt. Call after display_init().
+void ticker_start(app_state_t *s);
+
+// Task-side code must hold the ticker lock while touching the state.
+void ticker_lock(void);
+void ticker_unlock(void);
+
+void ticker_get_stats(ticker_stats_t *out);
+// Zero the tick count and gap maximum, e.g. to measure a single window.
+void ticker_reset_stats(void);
@@ -0,0 +1,123 @@
+#include <string.h>
+
+#include "unity.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/gpio.h"
+#include "esp_intr_alloc.h"
+#include "esp_partition.h"
+#include "esp_timer.h"
+#include "nvs_flash.h"
+#include "nvs.h"
+
+#include "app_state.h"
+#include "display.h"
+#include "ticker.h"
+#include "utils.h"
+
+#define TEST_PARTITION_SUBTYPE 0x40
+
+static app_state_t s_state;
+
+typedef struct {
+    int64_t at;
+    int     totalSeconds;
+} tick_window_t;
+
+// Bring up the real-time path once and leave a countdown running, so every
+// tick also walks the state machine and the display output.
+static void rt_path_start(void) {
+    static bool started;
+    if (started) return;
+    started = true;
+
+    TEST_ESP_OK(gpio_install_isr_service(ESP_INTR_FLAG_IRAM));
+    display_init(DUTY_NORMAL_VAL);
+    app_state_init(&s_state);
+    ticker_start(&s_state);
+
+    ticker_lock();
+    handleKey(&s_state, '9', millis_now());
+    handleKey(&s_state, '9', millis_now());
+    handleKey(&s_state, 'A', millis_now());
+    ticker_unlock();
+
+    // Let the pre-countdown animation finish.
+    vTaskDelay(pdMS_TO_TICKS(5000));
+    TEST_ASSERT_EQUAL(MODE_COUNTDOWN, s_state.mode);
+}
+
+// Start a measurement window: tick count and gap maximum restart at zero so
+// the checks only see what happened during the flash operations under test.
+static void window_begin(tick_window_t *w) {
+    ticker_lock();
+    w->totalSeconds = s_state.totalSeconds;
+    ticker_unlock();
+    ticker_reset_stats();
+    w->at = esp_timer_get_time();
+}
+
+static void window_check_no_missed_ticks(const tick_window_t *w) {
+    ticker_stats_t stats;
+    ticker_get_stats(&stats);
+    int64_t elapsed = esp_timer_get_time() - w->at;
+    ticker_lock();
+    int totalSeconds = s_state.totalSeconds;
+    ticker_unlock();
+
+    uint32_t expected = (uint32_t)(elapsed / TICKER_PERIOD_US);
+    TEST_ASSERT_UINT32_WITHIN(1, expected, stats.ticks);
+    TEST_ASSERT_LESS_THAN_UINT32(2 * TICKER_PERIOD_US, stats.max_gap_us);
+    // The countdown itself advanced by the elapsed wall-clock seconds.
+    TEST_ASSERT_INT_WITHIN(1, (int)(elapsed / 1000000),
+                           w->totalSeconds - totalSeconds);
+}
+
+TEST_CASE("display ticks during partition erase and write", "[ticker]") {
+    rt_path_start();
+    const esp_partition_t *part = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA, TEST_PARTITION_SUBTYPE, "flash_test");
+    TEST_ASSERT_NOT_NULL(part);
+
+    static uint8_t buf[4096];
+    memset(buf, 0xA5, sizeof(buf));
+
+    tick_window_t w;
+    window_begin(&w);
+    for (int i = 0; i < 4; i++) {
+        TEST_ESP_OK(esp_partition_erase_range(part, 0, part->size));
+        for (size_t off = 0; off < part->size; off += sizeof(buf)) {
+            TEST_ESP_OK(esp_partition_write(part, off, buf, sizeof(buf)));
+        }
+        vTaskDelay(1);
+    }
+    window_check_no_missed_ticks(&w);
+}
+
+TEST_CASE("display ticks during NVS writes", "[ticker]") {
+    rt_path_start();
+    esp_err_t err = nvs_flash_init();
+    if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        TEST_ESP_OK(nvs_flash_erase());
+        err = nvs_flash_init();
+    }
+    TEST_ESP_OK(err);
+
+    nvs_handle_t nvs;
+    TEST_ESP_OK(nvs_open("flash_tick", NVS_READWRITE, &nvs));
+
+    static uint8_t blob[512];
+    tick_window_t w;
+    window_begin(&w);
+    for (int i = 0; i < 500; i++) {
+        memset(blob, i, sizeof(blob));
+        TEST_ESP_OK(nvs_set_blob(nvs, "blob", blob, sizeof(blob)));
+        TEST_ESP_OK(nvs_commit(nvs));
+    }
+    window_check_no_missed_ticks(&w);
+    nvs_close(nvs);
+}
+
+void app_main(void) {
+    unity_run_menu();
+}